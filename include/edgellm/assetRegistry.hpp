@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <edgerunner/model.hpp>
+
+#include "edgellm/constrainedDecoder.hpp"
+#include "edgellm/edgellm_export.hpp"
+#include "edgellm/ropeEmbedding.hpp"
+#include "edgellm/tokenizer.hpp"
+
+namespace edgellm {
+
+class EDGELLM_EXPORT SharedModel {
+    /*
+    Loaded split model shared by several EdgeLLM instances
+
+    A model owns its input/output buffers, so the model is only reachable
+    through a Lease, which holds the model's lock for one fill inputs, execute,
+    read outputs sequence.
+    */
+
+  public:
+    class Lease {
+      public:
+        Lease(std::mutex& mutex, edge::Model& model)
+            : m_lock(mutex)
+            , m_model(&model) {}
+
+        auto operator->() const -> edge::Model* { return m_model; }
+
+        auto operator*() const -> edge::Model& { return *m_model; }
+
+      private:
+        std::unique_lock<std::mutex> m_lock;
+        edge::Model* m_model;
+    };
+
+    explicit SharedModel(std::unique_ptr<edge::Model> model)
+        : m_model(std::move(model)) {}
+
+    auto acquire() -> Lease { return {m_mutex, *m_model}; }
+
+  private:
+    std::mutex m_mutex;
+    std::unique_ptr<edge::Model> m_model;
+};
+
+/*
+Hands out reference-counted model assets so that several EdgeLLM instances in
+one process share a single copy of the tokenizer tables, the RoPE tables and
+the loaded split models. Tokenizers and RoPE tables are immutable, split models
+are serialized through SharedModel.
+
+Assets are only weakly cached: they are released once the last owner goes away.
+*/
+class EDGELLM_EXPORT AssetRegistry {
+  public:
+    AssetRegistry() = default;
+    AssetRegistry(const AssetRegistry&) = delete;
+    AssetRegistry(AssetRegistry&&) = delete;
+    auto operator=(const AssetRegistry&) -> AssetRegistry& = delete;
+    auto operator=(AssetRegistry&&) -> AssetRegistry& = delete;
+    ~AssetRegistry() = default;
+
+    /* process wide registry used by EdgeLLM unless one is supplied */
+    static auto global() -> const std::shared_ptr<AssetRegistry>&;
+
+    /* returns nullptr if the tokenizer could not be loaded */
+    auto getTokenizer(const std::filesystem::path& tokenizerPath)
+        -> std::shared_ptr<const Tokenizer>;
+
+    auto getRopeEmbedding(size_t headDim, size_t maxLength)
+        -> std::shared_ptr<const RopeEmbedding>;
+
+    /* returns nullptr if the tokenizer could not be loaded */
+    auto getTokenMaskCache(const std::filesystem::path& tokenizerPath)
+        -> std::shared_ptr<TokenMaskCache>;
+
+    /* returns nullptr if the model could not be created */
+    auto getModel(const std::filesystem::path& modelPath)
+        -> std::shared_ptr<SharedModel>;
+
+  private:
+    /*
+    Cache entry of one asset. Its lock is held while the asset loads, so that
+    concurrent requests for that asset wait for a single load while requests
+    for other assets go ahead.
+    */
+    template<typename T>
+    struct Slot {
+        std::mutex mutex;
+        std::weak_ptr<T> asset;
+    };
+
+    template<typename Key, typename T, typename Load>
+    auto getOrLoad(std::map<Key, Slot<T>>& slots, const Key& key, Load load)
+        -> std::shared_ptr<T>;
+
+    static auto makeKey(const std::filesystem::path& path)
+        -> std::filesystem::path;
+
+    // guards the maps only, never held while an asset loads
+    std::mutex m_mutex;
+
+    // slots are never erased, so references to them stay valid
+    std::map<std::filesystem::path, Slot<const Tokenizer>> m_tokenizers;
+    std::map<std::pair<size_t, size_t>, Slot<const RopeEmbedding>>
+        m_ropeEmbeddings;
+    std::map<std::filesystem::path, Slot<TokenMaskCache>> m_tokenMaskCaches;
+    std::map<std::filesystem::path, Slot<SharedModel>> m_models;
+};
+
+}  // namespace edgellm
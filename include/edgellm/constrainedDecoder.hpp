@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "edgellm/edgellm_export.hpp"
+#include "edgellm/jsonGrammar.hpp"
+#include "edgellm/tokenizer.hpp"
+
+namespace edgellm {
+
+class EDGELLM_EXPORT TokenMaskCache {
+    /*
+    Allowed tokens of each JSON grammar state over one tokenizer's vocabulary
+
+    Each state's tokens are computed once from the vocab pieces and kept as a
+    bitset over the vocabulary. One cache is meant to be shared by every
+    ConstrainedDecoder using the same tokenizer.
+    */
+
+  public:
+    explicit TokenMaskCache(const Tokenizer& tokenizer);
+
+    /* bit (token % 64) of word (token / 64) is set for allowed tokens */
+    auto getAllowedTokens(const JsonGrammar& grammar)
+        -> const std::vector<uint64_t>&;
+
+    /* empty for tokens constrained decoding never produces */
+    auto getPiece(size_t token) const -> const std::string& {
+        return m_pieces[token];
+    }
+
+    auto getVocabSize() const -> size_t { return m_vocabSize; }
+
+    auto getEosTok() const -> size_t { return m_eosId; }
+
+    auto getNumStates() const -> size_t;
+
+    static constexpr size_t MBitsPerWord = 64;
+
+  private:
+    auto computeAllowedTokens(const JsonGrammar& grammar) const
+        -> std::vector<uint64_t>;
+
+    size_t m_vocabSize;
+    size_t m_eosId;
+
+    std::vector<std::string> m_pieces;
+    // pieces in lexicographic order, so that tokens sharing a prefix are
+    // checked against the grammar only once for that prefix
+    std::vector<size_t> m_sortedPieceIndices;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, std::vector<uint64_t>> m_allowedTokens;
+
+    // <unk>, <s>, </s> are never produced by constrained decoding, except for
+    // </s> once the grammar is complete
+    static constexpr size_t MNumControlTokens = 3;
+};
+
+class EDGELLM_EXPORT ConstrainedDecoder {
+    /*
+    Restricts sampling to tokens that keep the output a valid JSON value
+
+    Call applyMask on the logits before Sampler::sample and accept with the
+    sampled token. The decoder only tracks the grammar state of one generation,
+    reset it to reuse it for the next one.
+    */
+
+  public:
+    explicit ConstrainedDecoder(std::shared_ptr<TokenMaskCache> maskCache);
+
+    template<typename T>
+    void applyMask(std::vector<T>& logits);
+
+    /* advance the grammar, returns false if the token is not allowed */
+    auto accept(size_t token) -> bool;
+
+    void reset() { m_grammar = {}; }
+
+    auto isComplete() const -> bool { return m_grammar.isComplete(); }
+
+    auto getAllowedTokens() -> const std::vector<uint64_t>& {
+        return m_maskCache->getAllowedTokens(m_grammar);
+    }
+
+  private:
+    std::shared_ptr<TokenMaskCache> m_maskCache;
+    JsonGrammar m_grammar;
+};
+
+}  // namespace edgellm
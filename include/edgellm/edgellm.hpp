@@ -1,11 +1,15 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <vector>
 
 #include <edgerunner/model.hpp>
 
+#include "edgellm/assetRegistry.hpp"
+#include "edgellm/constrainedDecoder.hpp"
 #include "edgellm/edgellm_export.hpp"
 #include "edgellm/ropeEmbedding.hpp"
 #include "edgellm/sampler.hpp"
@@ -17,21 +21,36 @@ class EDGELLM_EXPORT EdgeLLM {
   public:
     EdgeLLM(std::vector<std::filesystem::path>&& promptProcessorPaths,
             std::vector<std::filesystem::path>&& tokenGeneratorPaths,
-            const std::filesystem::path& tokenizerPath);
+            const std::filesystem::path& tokenizerPath,
+            const std::shared_ptr<AssetRegistry>& assetRegistry =
+                AssetRegistry::global());
 
     auto getCreationStatus() const -> bool { return m_creationSuccess; }
 
     auto generate(const std::string& prompt) -> std::vector<std::string>;
 
+    /*
+    Decoder restricting this model's output to JSON, apply it to the logits
+    before sampling. Decoders of every instance sharing the tokenizer share its
+    token masks. Returns std::nullopt if the instance failed to load.
+    */
+    auto createJsonDecoder() -> std::optional<ConstrainedDecoder>;
+
   private:
+    auto loadModels() -> bool;
+
+    std::shared_ptr<AssetRegistry> m_assetRegistry;
+
     std::vector<std::filesystem::path> m_promptProcessorPaths;
     std::vector<std::filesystem::path> m_tokenGeneratorPaths;
-    Tokenizer m_tokenizer;
+    std::filesystem::path m_tokenizerPath;
+    std::shared_ptr<const Tokenizer> m_tokenizer;
 
     bool m_creationSuccess {};
+    bool m_modelsLoaded {};
 
-    std::queue<std::unique_ptr<edge::Model>> m_promptProcessor;
-    std::queue<std::unique_ptr<edge::Model>> m_tokenGenerator;
+    std::queue<std::shared_ptr<SharedModel>> m_promptProcessor;
+    std::queue<std::shared_ptr<SharedModel>> m_tokenGenerator;
 
     static constexpr float MTemperature = 0.8F;
     static constexpr float MTopp = 0.9F;
@@ -40,6 +59,7 @@ class EDGELLM_EXPORT EdgeLLM {
     static constexpr int64_t MLogitsOffset = 0;
     static constexpr size_t MEvalMode = 0;
     static constexpr size_t MMaxSequenceLength = 1024;
+    static constexpr size_t MHeadDimension = 128;
 
     size_t m_vocabSize {};
     size_t m_bosId {};
@@ -49,7 +69,10 @@ class EDGELLM_EXPORT EdgeLLM {
 
     Sampler m_sampler;
 
-    RopeEmbedding m_ropeEmbedding;
+    std::shared_ptr<const RopeEmbedding> m_ropeEmbedding;
+
+    // built on first use, most generations are unconstrained
+    std::shared_ptr<TokenMaskCache> m_tokenMaskCache;
 
     static constexpr size_t MNumKVHeads = 32;
     static constexpr size_t MNumLayersPerSplit = 8;
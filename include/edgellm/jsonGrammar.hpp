@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "edgellm/edgellm_export.hpp"
+
+namespace edgellm {
+
+class EDGELLM_EXPORT JsonGrammar {
+    /*
+    Byte level recognizer for a single JSON value (RFC 8259)
+
+    Drives ConstrainedDecoder: bytes are fed one at a time through consume, and
+    getStateKey identifies the recognizer state so that states reached through
+    different text share their cached allowed tokens.
+    */
+
+  public:
+    /* returns false if byte cannot extend the text consumed so far */
+    auto consume(char byte) -> bool;
+
+    /* the text consumed so far is a complete JSON value */
+    auto isComplete() const -> bool;
+
+    auto getStateKey() const -> std::string;
+
+  private:
+    enum class State : uint8_t {
+        Value,
+        FirstValue,  // after '[', also allows ']'
+        FirstKey,  // after '{', also allows '}'
+        Key,
+        Colon,
+        AfterValue,
+        String,
+        Escape,
+        Unicode,
+        Minus,
+        Zero,
+        Integer,
+        FractionStart,
+        Fraction,
+        ExponentStart,
+        ExponentSign,
+        Exponent,
+        Literal,
+    };
+
+    auto consumeValue(char byte) -> bool;
+    auto consumeAfterValue(char byte) -> bool;
+    auto consumeNumber(char byte) -> bool;
+    auto consumeStringByte(unsigned char byte) -> bool;
+
+    static auto isWhitespace(char byte) -> bool {
+        return byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r';
+    }
+
+    static auto isDigit(char byte) -> bool {
+        return byte >= '0' && byte <= '9';
+    }
+
+    static constexpr uint8_t MContinuationMin = 0x80;
+    static constexpr uint8_t MContinuationMax = 0xBF;
+
+    State m_state = State::Value;
+
+    // open containers, '{' or '['
+    std::string m_stack;
+
+    bool m_inKey = false;
+    size_t m_remainingHex = 0;
+
+    // continuation bytes still expected by the current UTF-8 sequence, and the
+    // range the next one must fall into (excludes overlongs and surrogates)
+    uint8_t m_remainingUtf8 = 0;
+    uint8_t m_utf8Min = MContinuationMin;
+    uint8_t m_utf8Max = MContinuationMax;
+
+    const char* m_literal = nullptr;
+    size_t m_literalIndex = 0;
+};
+
+}  // namespace edgellm
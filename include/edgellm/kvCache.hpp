@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "edgellm/edgellm_export.hpp"
+
+namespace edgellm {
+
+class EDGELLM_EXPORT KVBlockPool {
+    /*
+    Fixed size pool of reference counted KV cache blocks
+
+    A block holds the keys and values of blockSize consecutive positions. Blocks
+    are shared between sequences with a common prefix and only duplicated when
+    a sharing sequence writes to them (copy-on-write).
+    */
+
+  public:
+    KVBlockPool(size_t numBlocks, size_t blockSize, size_t bytesPerPosition);
+
+    auto allocate() -> std::optional<size_t>;
+
+    void retain(size_t block);
+
+    void release(size_t block);
+
+    /* returns block if it is not shared, otherwise a private copy of it */
+    auto makeWritable(size_t block) -> std::optional<size_t>;
+
+    auto getRefCount(size_t block) const -> size_t {
+        return m_refCounts[block];
+    }
+
+    auto getNumFreeBlocks() const -> size_t { return m_freeBlocks.size(); }
+
+    auto getBlockSize() const -> size_t { return m_blockSize; }
+
+    auto getBytesPerPosition() const -> size_t { return m_bytesPerPosition; }
+
+    auto getData(size_t block) -> uint8_t* {
+        return &m_storage[block * m_blockSize * m_bytesPerPosition];
+    }
+
+    auto getData(size_t block) const -> const uint8_t* {
+        return &m_storage[block * m_blockSize * m_bytesPerPosition];
+    }
+
+  private:
+    size_t m_blockSize;
+    size_t m_bytesPerPosition;
+
+    std::vector<uint8_t> m_storage;
+    std::vector<size_t> m_refCounts;
+    std::vector<size_t> m_freeBlocks;
+};
+
+class EDGELLM_EXPORT KVBlockTable {
+    /*
+    Maps the positions of one sequence onto blocks of a KVBlockPool
+
+    Copying a table forks the sequence: the copy shares every block with the
+    original until either of them appends to a partially filled block.
+    */
+
+  public:
+    explicit KVBlockTable(KVBlockPool& pool)
+        : m_pool(&pool) {}
+
+    KVBlockTable(const KVBlockTable& other);
+    KVBlockTable(KVBlockTable&& other) noexcept;
+    auto operator=(const KVBlockTable& other) -> KVBlockTable&;
+    auto operator=(KVBlockTable&& other) noexcept -> KVBlockTable&;
+    ~KVBlockTable();
+
+    /*
+    Reserve the next position, returns its writable slot or nullptr if the pool
+    is exhausted
+    */
+    auto appendSlot() -> uint8_t*;
+
+    auto getSlot(size_t position) const -> const uint8_t*;
+
+    auto getNumPositions() const -> size_t { return m_numPositions; }
+
+    auto getBlocks() const -> const std::vector<size_t>& { return m_blocks; }
+
+    auto getPool() const -> const KVBlockPool& { return *m_pool; }
+
+  private:
+    void releaseBlocks();
+
+    KVBlockPool* m_pool;
+    std::vector<size_t> m_blocks;
+    size_t m_numPositions = 0;
+};
+
+}  // namespace edgellm
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <algorithm>
 #include <cmath>
 #include <numeric>
@@ -57,7 +59,7 @@ class RopeEmbedding {
         }
     }
 
-    auto getEmbedding(const std::vector<size_t>& positionIds)
+    auto getEmbedding(const std::vector<size_t>& positionIds) const
         -> std::pair<std::vector<float>, std::vector<float>> {
         /*
         position_ids: [batch_size, sequence_length]
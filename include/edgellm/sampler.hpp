@@ -1,8 +1,16 @@
+#pragma once
+
 #include <random>
 #include <vector>
 
 namespace edgellm {
 
+struct BeamCandidate {
+    size_t beam;
+    size_t token;
+    float score;
+};  // extension of beam `beam` by `token`, scored by cumulative log-probability
+
 class Sampler {
   public:
     Sampler(size_t vocabSize, float temperature, float topp);
@@ -10,6 +18,16 @@ class Sampler {
     template<typename T>
     auto sample(std::vector<T>& logits) -> size_t;
 
+    // sample one token for each of several branches sharing this sampler
+    template<typename T>
+    auto sample(std::vector<std::vector<T>>& logits) -> std::vector<size_t>;
+
+    // best `beamWidth` single token extensions over all beams
+    template<typename T>
+    auto sampleBeams(const std::vector<std::vector<T>>& logits,
+                     const std::vector<float>& beamScores,
+                     size_t beamWidth) const -> std::vector<BeamCandidate>;
+
   private:
     template<typename T>
     auto sampleTopP(std::vector<T>&, float coin) -> size_t;
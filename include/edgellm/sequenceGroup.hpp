@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "edgellm/edgellm_export.hpp"
+#include "edgellm/kvCache.hpp"
+#include "edgellm/sampler.hpp"
+
+namespace edgellm {
+
+struct SequenceBranch {
+    KVBlockTable kvBlocks;
+    std::vector<size_t> tokens;  // generated tokens, prompt excluded
+    float score = 0.0F;  // cumulative log-probability, beam search only
+    bool finished = false;
+    uint8_t* kvSlot = nullptr;  // keys/values of the last token go here
+};
+
+class EDGELLM_EXPORT SequenceGroup {
+    /*
+    Candidate continuations of one prompt decoded over a single prefill
+
+    Every branch starts from the prompt's KV blocks and owns new blocks only
+    where it diverges from the others.
+
+    Each step takes one logits vector per unfinished branch, in branch order,
+    appends the chosen token to the branch and reserves its KV slot. Callers
+    then run the token generator for every unfinished branch and write the new
+    keys/values into the matching entry of getKVSlots().
+
+    A step that returns false leaves the group unchanged. Steps fail when the
+    KV pool cannot hold the new blocks they need: a fresh block for a branch
+    at a block boundary, a copy for a branch whose tail block is still shared.
+    */
+
+  public:
+    /* n-way sampling group, every branch starts from the prompt */
+    SequenceGroup(const KVBlockTable& promptBlocks,
+                  size_t numBranches,
+                  size_t eosId);
+
+    /* beam search group, starts from a single beam on the prompt */
+    static auto forBeamSearch(const KVBlockTable& promptBlocks, size_t eosId)
+        -> SequenceGroup;
+
+    /*
+    n-way sampling, returns false if the KV pool cannot hold the step. The
+    sampler has consumed the logits by then.
+    */
+    auto sampleStep(Sampler& sampler, std::vector<std::vector<float>>& logits)
+        -> bool;
+
+    /*
+    Beam search over beamWidth beams, only valid on groups made by
+    forBeamSearch. Returns false if the KV pool cannot hold the step.
+    */
+    auto beamStep(const Sampler& sampler,
+                  const std::vector<std::vector<float>>& logits,
+                  size_t beamWidth) -> bool;
+
+    /* writable KV slots of the unfinished branches, in branch order */
+    auto getKVSlots() -> std::vector<uint8_t*>;
+
+    auto isFinished() const -> bool;
+
+    auto getNumActive() const -> size_t;
+
+    auto getBranches() const -> const std::vector<SequenceBranch>& {
+        return m_branches;
+    }
+
+  private:
+    auto appendToken(SequenceBranch& branch, size_t token) const -> bool;
+
+    /*
+    parents[i] is the branch the i-th next branch is forked from, extended[i]
+    whether it appends a token that needs a KV slot
+    */
+    auto hasFreeBlocks(const std::vector<size_t>& parents,
+                       const std::vector<bool>& extended) const -> bool;
+
+    std::vector<SequenceBranch> m_branches;
+    size_t m_eosId;
+    bool m_beamSearch = false;
+};
+
+}  // namespace edgellm
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "edgellm/edgellm_export.hpp"
+
+namespace edgellm {
+
+class EDGELLM_EXPORT StopSequenceMatcher {
+    /*
+    Streaming detection of stop sequences in decoded output
+
+    Aho-Corasick automaton over bytes with a complete transition table, so that
+    each byte costs a single lookup regardless of the number of stop sequences.
+    Feed the detokenizer output piece by piece, matches spanning pieces are
+    found the moment their last byte arrives.
+    */
+
+  public:
+    explicit StopSequenceMatcher(
+        const std::vector<std::string>& stopSequences = {});
+
+    /*
+    Returns the offset just past the end of the first stop sequence completed
+    within piece, if any
+    */
+    auto feed(const std::string& piece) -> std::optional<size_t>;
+
+    /* returns true if a stop sequence ends with byte */
+    auto consume(char byte) -> bool {
+        m_state = m_transitions[m_state][static_cast<unsigned char>(byte)];
+        return m_matchLengths[m_state] != 0;
+    }
+
+    /* length of the stop sequence matched by the last byte, 0 if none */
+    auto getMatchLength() const -> size_t { return m_matchLengths[m_state]; }
+
+    void reset() { m_state = 0; }
+
+  private:
+    static constexpr size_t MNumByteValues = 256;
+
+    std::vector<std::array<uint32_t, MNumByteValues>> m_transitions;
+    std::vector<size_t> m_matchLengths;
+    uint32_t m_state = 0;
+};
+
+}  // namespace edgellm
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 #include <filesystem>
 #include <string>
@@ -26,6 +28,9 @@ class Tokenizer {
 
     auto decode(size_t prevToken, size_t token) const -> std::string;
 
+    // raw bytes a token decodes to, regardless of the preceding token
+    auto getPiece(size_t token) const -> std::string;
+
     auto getVocabSize() const -> size_t { return m_vocabSize; }
 
     auto getBosTok() const -> size_t { return m_bosTok; }
@@ -33,6 +38,8 @@ class Tokenizer {
     auto getEosTok() const -> size_t { return m_eosTok; }
 
   private:
+    static auto pieceToBytes(const std::string& piece) -> std::string;
+
     auto strLookup(const std::string& str) const -> int32_t;
 
     size_t m_vocabSize = 0;
@@ -0,0 +1,111 @@
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include "edgellm/assetRegistry.hpp"
+
+#include <edgerunner/edgerunner.hpp>
+#include <edgerunner/model.hpp>
+
+#include "edgellm/constrainedDecoder.hpp"
+#include "edgellm/ropeEmbedding.hpp"
+#include "edgellm/tokenizer.hpp"
+
+namespace edgellm {
+
+auto AssetRegistry::global() -> const std::shared_ptr<AssetRegistry>& {
+    static const auto Registry = std::make_shared<AssetRegistry>();
+    return Registry;
+}
+
+auto AssetRegistry::makeKey(const std::filesystem::path& path)
+    -> std::filesystem::path {
+    // different spellings of the same file should resolve to the same asset
+    std::error_code error;
+    auto key = std::filesystem::weakly_canonical(path, error);
+    return error ? path.lexically_normal() : key;
+}
+
+template<typename Key, typename T, typename Load>
+auto AssetRegistry::getOrLoad(std::map<Key, Slot<T>>& slots,
+                              const Key& key,
+                              Load load) -> std::shared_ptr<T> {
+    auto& slot = [&]() -> Slot<T>& {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return slots[key];
+    }();
+
+    const std::lock_guard<std::mutex> lock(slot.mutex);
+
+    if (auto asset = slot.asset.lock()) {
+        return asset;
+    }
+
+    auto asset = load();
+    if (asset != nullptr) {
+        slot.asset = asset;
+    }
+    return asset;
+}
+
+auto AssetRegistry::getTokenizer(const std::filesystem::path& tokenizerPath)
+    -> std::shared_ptr<const Tokenizer> {
+    return getOrLoad(
+        m_tokenizers,
+        makeKey(tokenizerPath),
+        [&tokenizerPath]() -> std::shared_ptr<const Tokenizer> {
+            auto tokenizer = std::make_shared<Tokenizer>();
+            if (!tokenizer->load(tokenizerPath)) {
+                return nullptr;
+            }
+            return tokenizer;
+        });
+}
+
+auto AssetRegistry::getRopeEmbedding(size_t headDim, size_t maxLength)
+    -> std::shared_ptr<const RopeEmbedding> {
+    return getOrLoad(m_ropeEmbeddings,
+                     std::make_pair(headDim, maxLength),
+                     [headDim, maxLength]() {
+                         return std::make_shared<const RopeEmbedding>(
+                             headDim, maxLength);
+                     });
+}
+
+auto AssetRegistry::getTokenMaskCache(
+    const std::filesystem::path& tokenizerPath)
+    -> std::shared_ptr<TokenMaskCache> {
+    return getOrLoad(
+        m_tokenMaskCaches,
+        makeKey(tokenizerPath),
+        [this, &tokenizerPath]() -> std::shared_ptr<TokenMaskCache> {
+            // takes the tokenizer's own slot, never the mask cache's
+            const auto tokenizer = getTokenizer(tokenizerPath);
+            if (tokenizer == nullptr) {
+                return nullptr;
+            }
+            return std::make_shared<TokenMaskCache>(*tokenizer);
+        });
+}
+
+auto AssetRegistry::getModel(const std::filesystem::path& modelPath)
+    -> std::shared_ptr<SharedModel> {
+    return getOrLoad(
+        m_models,
+        makeKey(modelPath),
+        [&modelPath]() -> std::shared_ptr<SharedModel> {
+            auto model = edge::createModel(modelPath);
+            if (model == nullptr
+                || model->getCreationStatus() != edge::STATUS::SUCCESS)
+            {
+                return nullptr;
+            }
+            return std::make_shared<SharedModel>(std::move(model));
+        });
+}
+
+}  // namespace edgellm
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "edgellm/constrainedDecoder.hpp"
+
+#include "edgellm/jsonGrammar.hpp"
+#include "edgellm/tokenizer.hpp"
+
+namespace edgellm {
+
+TokenMaskCache::TokenMaskCache(const Tokenizer& tokenizer)
+    : m_vocabSize(tokenizer.getVocabSize())
+    , m_eosId(tokenizer.getEosTok())
+    , m_pieces(m_vocabSize) {
+    for (size_t token = MNumControlTokens; token < m_vocabSize; ++token) {
+        m_pieces[token] = tokenizer.getPiece(token);
+        if (!m_pieces[token].empty()) {
+            m_sortedPieceIndices.push_back(token);
+        }
+    }
+
+    std::sort(m_sortedPieceIndices.begin(),
+              m_sortedPieceIndices.end(),
+              [this](auto index1, auto index2) {
+                  return m_pieces[index1] < m_pieces[index2];
+              });
+}
+
+auto TokenMaskCache::computeAllowedTokens(const JsonGrammar& grammar) const
+    -> std::vector<uint64_t> {
+    std::vector<uint64_t> allowed((m_vocabSize + MBitsPerWord - 1)
+                                  / MBitsPerWord);
+
+    // prefixStates[i] is the grammar after the first i bytes of the previous
+    // piece, for as long as those bytes were accepted
+    std::vector<JsonGrammar> prefixStates {grammar};
+    const std::string* previous = nullptr;
+
+    for (const auto token : m_sortedPieceIndices) {
+        const auto& piece = m_pieces[token];
+
+        size_t depth = 0;
+        if (previous != nullptr) {
+            const auto limit = std::min(piece.size(), prefixStates.size() - 1);
+            while (depth < limit && piece[depth] == (*previous)[depth]) {
+                ++depth;
+            }
+        }
+        prefixStates.resize(depth + 1);
+        previous = &piece;
+
+        for (; depth < piece.size(); ++depth) {
+            auto next = prefixStates.back();
+            if (!next.consume(piece[depth])) {
+                break;
+            }
+            prefixStates.push_back(std::move(next));
+        }
+
+        if (depth == piece.size()) {
+            allowed[token / MBitsPerWord] |= uint64_t {1}
+                << (token % MBitsPerWord);
+        }
+    }
+
+    if (grammar.isComplete() && m_eosId < m_vocabSize) {
+        allowed[m_eosId / MBitsPerWord] |= uint64_t {1}
+            << (m_eosId % MBitsPerWord);
+    }
+
+    return allowed;
+}
+
+auto TokenMaskCache::getAllowedTokens(const JsonGrammar& grammar)
+    -> const std::vector<uint64_t>& {
+    auto key = grammar.getStateKey();
+
+    // elements of an unordered_map keep their address, so the returned
+    // reference stays valid while other decoders add states
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto cached = m_allowedTokens.find(key);
+    if (cached == m_allowedTokens.end()) {
+        cached = m_allowedTokens
+                     .emplace(std::move(key), computeAllowedTokens(grammar))
+                     .first;
+    }
+
+    return cached->second;
+}
+
+auto TokenMaskCache::getNumStates() const -> size_t {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allowedTokens.size();
+}
+
+ConstrainedDecoder::ConstrainedDecoder(
+    std::shared_ptr<TokenMaskCache> maskCache)
+    : m_maskCache(std::move(maskCache)) {}
+
+template<typename T>
+void ConstrainedDecoder::applyMask(std::vector<T>& logits) {
+    constexpr auto Masked = -std::numeric_limits<T>::infinity();
+    constexpr auto AllAllowed = std::numeric_limits<uint64_t>::max();
+    constexpr auto BitsPerWord = TokenMaskCache::MBitsPerWord;
+
+    // logits past the end of a short output have nothing to mask
+    const auto vocabSize = std::min(m_maskCache->getVocabSize(), logits.size());
+    const auto numWords = (vocabSize + BitsPerWord - 1) / BitsPerWord;
+    const auto& allowed = getAllowedTokens();
+
+    // whole words are handled at once, most words are either fully allowed or
+    // fully masked
+    for (size_t word = 0; word < numWords; ++word) {
+        const auto bits = allowed[word];
+        if (bits == AllAllowed) {
+            continue;
+        }
+
+        const auto begin = word * BitsPerWord;
+        const auto end = std::min(begin + BitsPerWord, vocabSize);
+        auto* wordLogits = logits.data() + begin;
+
+        if (bits == 0) {
+            std::fill(wordLogits, wordLogits + (end - begin), Masked);
+            continue;
+        }
+
+        for (size_t bit = 0; bit < end - begin; ++bit) {
+            wordLogits[bit] =
+                ((bits >> bit) & 1U) != 0 ? wordLogits[bit] : Masked;
+        }
+    }
+}
+
+auto ConstrainedDecoder::accept(size_t token) -> bool {
+    if (token == m_maskCache->getEosTok()) {
+        return m_grammar.isComplete();
+    }
+    if (token >= m_maskCache->getVocabSize()) {
+        return false;
+    }
+
+    const auto& piece = m_maskCache->getPiece(token);
+    if (piece.empty()) {
+        return false;
+    }
+
+    // keep the current state if the token turns out to be invalid
+    auto next = m_grammar;
+    for (const auto byte : piece) {
+        if (!next.consume(byte)) {
+            return false;
+        }
+    }
+    m_grammar = std::move(next);
+
+    return true;
+}
+
+template void ConstrainedDecoder::applyMask<float>(std::vector<float>& logits);
+
+}  // namespace edgellm
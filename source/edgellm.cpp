@@ -1,27 +1,88 @@
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <utility>
 #include <vector>
 
 #include "edgellm/edgellm.hpp"
 
-#include <edgerunner/edgerunner.hpp>
 #include <edgerunner/model.hpp>
 
+#include "edgellm/assetRegistry.hpp"
+#include "edgellm/constrainedDecoder.hpp"
+
 namespace edgellm {
 
 EdgeLLM::EdgeLLM(std::vector<std::filesystem::path>&& promptProcessorPaths,
                  std::vector<std::filesystem::path>&& tokenGeneratorPaths,
-                 const std::filesystem::path& tokenizerPath)
-    : m_promptProcessorPaths(std::move(promptProcessorPaths))
+                 const std::filesystem::path& tokenizerPath,
+                 const std::shared_ptr<AssetRegistry>& assetRegistry)
+    : m_assetRegistry(assetRegistry)
+    , m_promptProcessorPaths(std::move(promptProcessorPaths))
     , m_tokenGeneratorPaths(std::move(tokenGeneratorPaths))
-    , m_creationSuccess(m_tokenizer.load(tokenizerPath))
-    , m_vocabSize(m_tokenizer.getVocabSize())
-    , m_bosId(m_tokenizer.getBosTok())
-    , m_eosId(m_tokenizer.getEosTok())
+    , m_tokenizerPath(tokenizerPath)
+    , m_tokenizer(m_assetRegistry->getTokenizer(m_tokenizerPath))
+    , m_creationSuccess(m_tokenizer != nullptr)
+    , m_vocabSize(m_creationSuccess ? m_tokenizer->getVocabSize() : 0)
+    , m_bosId(m_creationSuccess ? m_tokenizer->getBosTok() : 0)
+    , m_eosId(m_creationSuccess ? m_tokenizer->getEosTok() : 0)
     , m_sampler(m_vocabSize, MTemperature, MTopp)
-    , m_ropeEmbedding(128, MMaxSequenceLength) {}
+    , m_ropeEmbedding(m_assetRegistry->getRopeEmbedding(MHeadDimension,
+                                                        MMaxSequenceLength)) {}
+
+auto EdgeLLM::loadModels() -> bool {
+    if (m_modelsLoaded) {
+        return true;
+    }
+
+    // split models already loaded by another instance are shared, not reloaded
+    std::queue<std::shared_ptr<SharedModel>> promptProcessor;
+    for (const auto& modelPath : m_promptProcessorPaths) {
+        auto model = m_assetRegistry->getModel(modelPath);
+        if (model == nullptr) {
+            return false;
+        }
+        promptProcessor.push(std::move(model));
+    }
+
+    std::queue<std::shared_ptr<SharedModel>> tokenGenerator;
+    for (const auto& modelPath : m_tokenGeneratorPaths) {
+        auto model = m_assetRegistry->getModel(modelPath);
+        if (model == nullptr) {
+            return false;
+        }
+        tokenGenerator.push(std::move(model));
+    }
+
+    m_promptProcessor = std::move(promptProcessor);
+    m_tokenGenerator = std::move(tokenGenerator);
+    m_modelsLoaded = true;
+
+    return true;
+}
+
+auto EdgeLLM::createJsonDecoder() -> std::optional<ConstrainedDecoder> {
+    if (!m_creationSuccess) {
+        return std::nullopt;
+    }
+
+    if (m_tokenMaskCache == nullptr) {
+        m_tokenMaskCache = m_assetRegistry->getTokenMaskCache(m_tokenizerPath);
+        if (m_tokenMaskCache == nullptr) {
+            return std::nullopt;
+        }
+    }
+
+    return ConstrainedDecoder(m_tokenMaskCache);
+}
 
 auto EdgeLLM::generate(const std::string& prompt) -> std::vector<std::string> {
-    const auto inputTokens = m_tokenizer.encode(prompt, MNBos, MNEos);
+    if (!m_creationSuccess || !loadModels()) {
+        return {};
+    }
+
+    const auto inputTokens = m_tokenizer->encode(prompt, MNBos, MNEos);
 
     if (inputTokens.size() > MMaxSequenceLength) {
         return {};
@@ -30,7 +91,7 @@ auto EdgeLLM::generate(const std::string& prompt) -> std::vector<std::string> {
     const auto startIndex = MMaxSequenceLength - inputTokens.size();
 
     const auto [positionIdsCos, positionIdsSin] =
-        m_ropeEmbedding.getEmbedding(inputTokens);
+        m_ropeEmbedding->getEmbedding(inputTokens);
 
     return {};
 }
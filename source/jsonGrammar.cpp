@@ -0,0 +1,299 @@
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#include "edgellm/jsonGrammar.hpp"
+
+namespace edgellm {
+
+auto JsonGrammar::consume(char byte) -> bool {
+    switch (m_state) {
+        case State::Value:
+        case State::FirstValue:
+            if (isWhitespace(byte)) {
+                return true;
+            }
+            if (m_state == State::FirstValue && byte == ']') {
+                m_stack.pop_back();
+                m_state = State::AfterValue;
+                return true;
+            }
+            return consumeValue(byte);
+        case State::FirstKey:
+        case State::Key:
+            if (isWhitespace(byte)) {
+                return true;
+            }
+            if (m_state == State::FirstKey && byte == '}') {
+                m_stack.pop_back();
+                m_state = State::AfterValue;
+                return true;
+            }
+            if (byte == '"') {
+                m_state = State::String;
+                m_inKey = true;
+                return true;
+            }
+            return false;
+        case State::Colon:
+            if (isWhitespace(byte)) {
+                return true;
+            }
+            if (byte == ':') {
+                m_state = State::Value;
+                return true;
+            }
+            return false;
+        case State::AfterValue:
+            return consumeAfterValue(byte);
+        case State::String:
+            return consumeStringByte(static_cast<unsigned char>(byte));
+        case State::Escape:
+            if (byte == 'u') {
+                m_state = State::Unicode;
+                m_remainingHex = 4;
+                return true;
+            }
+            if (byte != '\0' && std::strchr("\"\\/bfnrt", byte) != nullptr) {
+                m_state = State::String;
+                return true;
+            }
+            return false;
+        case State::Unicode:
+            if (std::isxdigit(static_cast<unsigned char>(byte)) == 0) {
+                return false;
+            }
+            if (--m_remainingHex == 0) {
+                m_state = State::String;
+            }
+            return true;
+        case State::Literal:
+            if (byte != m_literal[m_literalIndex]) { /* NOLINT */
+                return false;
+            }
+            if (m_literal[++m_literalIndex] == '\0') { /* NOLINT */
+                m_state = State::AfterValue;
+                m_literal = nullptr;
+                m_literalIndex = 0;
+            }
+            return true;
+        default:
+            return consumeNumber(byte);
+    }
+}
+
+auto JsonGrammar::consumeStringByte(unsigned char byte) -> bool {
+    if (m_remainingUtf8 != 0) {
+        if (byte < m_utf8Min || byte > m_utf8Max) {
+            return false;
+        }
+        --m_remainingUtf8;
+        m_utf8Min = MContinuationMin;
+        m_utf8Max = MContinuationMax;
+        return true;
+    }
+
+    if (byte == '"') {
+        m_state = m_inKey ? State::Colon : State::AfterValue;
+        m_inKey = false;
+        return true;
+    }
+    if (byte == '\\') {
+        m_state = State::Escape;
+        return true;
+    }
+
+    // control characters must be escaped
+    if (byte < 0x20U) { /* NOLINT */
+        return false;
+    }
+    if (byte < MContinuationMin) {
+        return true;
+    }
+
+    // strings must be well-formed UTF-8 (RFC 3629, section 4), the lead byte
+    // decides the length of the sequence and the range of its second byte
+    if (byte >= 0xC2U && byte <= 0xDFU) { /* NOLINT */
+        m_remainingUtf8 = 1;
+    } else if (byte >= 0xE0U && byte <= 0xEFU) { /* NOLINT */
+        m_remainingUtf8 = 2;
+        if (byte == 0xE0U) { /* NOLINT */
+            m_utf8Min = 0xA0U; /* NOLINT */
+        } else if (byte == 0xEDU) { /* NOLINT */
+            m_utf8Max = 0x9FU; /* NOLINT */
+        }
+    } else if (byte >= 0xF0U && byte <= 0xF4U) { /* NOLINT */
+        m_remainingUtf8 = 3;
+        if (byte == 0xF0U) { /* NOLINT */
+            m_utf8Min = 0x90U; /* NOLINT */
+        } else if (byte == 0xF4U) { /* NOLINT */
+            m_utf8Max = 0x8FU; /* NOLINT */
+        }
+    } else {
+        // stray continuation bytes, overlong leads and bytes beyond U+10FFFF
+        return false;
+    }
+    return true;
+}
+
+auto JsonGrammar::consumeValue(char byte) -> bool {
+    switch (byte) {
+        case '{':
+            m_stack.push_back(byte);
+            m_state = State::FirstKey;
+            return true;
+        case '[':
+            m_stack.push_back(byte);
+            m_state = State::FirstValue;
+            return true;
+        case '"':
+            m_state = State::String;
+            return true;
+        case '-':
+            m_state = State::Minus;
+            return true;
+        case '0':
+            m_state = State::Zero;
+            return true;
+        case 't':
+            m_literal = "true";
+            break;
+        case 'f':
+            m_literal = "false";
+            break;
+        case 'n':
+            m_literal = "null";
+            break;
+        default:
+            if (isDigit(byte)) {
+                m_state = State::Integer;
+                return true;
+            }
+            return false;
+    }
+
+    // the first character of the literal has been matched
+    m_state = State::Literal;
+    m_literalIndex = 1;
+    return true;
+}
+
+auto JsonGrammar::consumeAfterValue(char byte) -> bool {
+    if (isWhitespace(byte)) {
+        return true;
+    }
+    if (m_stack.empty()) {
+        return false;
+    }
+
+    const auto isObject = m_stack.back() == '{';
+    if (byte == ',') {
+        m_state = isObject ? State::Key : State::Value;
+        return true;
+    }
+    if (byte == (isObject ? '}' : ']')) {
+        m_stack.pop_back();
+        m_state = State::AfterValue;
+        return true;
+    }
+    return false;
+}
+
+auto JsonGrammar::consumeNumber(char byte) -> bool {
+    const auto isExponent = byte == 'e' || byte == 'E';
+
+    switch (m_state) {
+        case State::Minus:
+            if (!isDigit(byte)) {
+                return false;
+            }
+            m_state = byte == '0' ? State::Zero : State::Integer;
+            return true;
+        case State::Zero:
+        case State::Integer:
+            if (m_state == State::Integer && isDigit(byte)) {
+                return true;
+            }
+            if (byte == '.') {
+                m_state = State::FractionStart;
+                return true;
+            }
+            if (isExponent) {
+                m_state = State::ExponentStart;
+                return true;
+            }
+            break;
+        case State::FractionStart:
+            if (!isDigit(byte)) {
+                return false;
+            }
+            m_state = State::Fraction;
+            return true;
+        case State::Fraction:
+            if (isDigit(byte)) {
+                return true;
+            }
+            if (isExponent) {
+                m_state = State::ExponentStart;
+                return true;
+            }
+            break;
+        case State::ExponentStart:
+            if (byte == '+' || byte == '-') {
+                m_state = State::ExponentSign;
+                return true;
+            }
+            [[fallthrough]];
+        case State::ExponentSign:
+            if (!isDigit(byte)) {
+                return false;
+            }
+            m_state = State::Exponent;
+            return true;
+        case State::Exponent:
+            if (isDigit(byte)) {
+                return true;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    // numbers have no terminator, the byte belongs to what follows
+    m_state = State::AfterValue;
+    return consumeAfterValue(byte);
+}
+
+auto JsonGrammar::isComplete() const -> bool {
+    if (!m_stack.empty()) {
+        return false;
+    }
+
+    switch (m_state) {
+        case State::AfterValue:
+        case State::Zero:
+        case State::Integer:
+        case State::Fraction:
+        case State::Exponent:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto JsonGrammar::getStateKey() const -> std::string {
+    // string contents and number digits do not show up in the key, so that
+    // most decoding steps hit an already computed token mask
+    auto key = m_stack;
+    key.push_back(static_cast<char>(m_state));
+    key.push_back(static_cast<char>(m_inKey));
+    key.push_back(static_cast<char>(m_remainingHex));
+    key.push_back(static_cast<char>(m_remainingUtf8));
+    key.push_back(static_cast<char>(m_utf8Min));
+    key.push_back(static_cast<char>(m_utf8Max));
+    key.push_back(m_literal != nullptr ? m_literal[0] : '\0');
+    key.push_back(static_cast<char>(m_literalIndex));
+    return key;
+}
+
+}  // namespace edgellm
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "edgellm/kvCache.hpp"
+
+namespace edgellm {
+
+KVBlockPool::KVBlockPool(size_t numBlocks,
+                         size_t blockSize, /* NOLINT */
+                         size_t bytesPerPosition)
+    : m_blockSize(blockSize)
+    , m_bytesPerPosition(bytesPerPosition)
+    , m_storage(numBlocks * blockSize * bytesPerPosition)
+    , m_refCounts(numBlocks)
+    , m_freeBlocks(numBlocks) {
+    // hand out low block indices first
+    std::iota(m_freeBlocks.rbegin(), m_freeBlocks.rend(), 0);
+}
+
+auto KVBlockPool::allocate() -> std::optional<size_t> {
+    if (m_freeBlocks.empty()) {
+        return std::nullopt;
+    }
+
+    const auto block = m_freeBlocks.back();
+    m_freeBlocks.pop_back();
+    m_refCounts[block] = 1;
+
+    return block;
+}
+
+void KVBlockPool::retain(size_t block) {
+    ++m_refCounts[block];
+}
+
+void KVBlockPool::release(size_t block) {
+    if (--m_refCounts[block] == 0) {
+        m_freeBlocks.push_back(block);
+    }
+}
+
+auto KVBlockPool::makeWritable(size_t block) -> std::optional<size_t> {
+    if (m_refCounts[block] == 1) {
+        return block;
+    }
+
+    const auto copy = allocate();
+    if (!copy) {
+        return std::nullopt;
+    }
+
+    const auto* source = getData(block);
+    std::copy(
+        source, source + m_blockSize * m_bytesPerPosition, getData(*copy));
+    release(block);
+
+    return copy;
+}
+
+KVBlockTable::KVBlockTable(const KVBlockTable& other)
+    : m_pool(other.m_pool)
+    , m_blocks(other.m_blocks)
+    , m_numPositions(other.m_numPositions) {
+    for (const auto block : m_blocks) {
+        m_pool->retain(block);
+    }
+}
+
+KVBlockTable::KVBlockTable(KVBlockTable&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_blocks(std::move(other.m_blocks))
+    , m_numPositions(std::exchange(other.m_numPositions, 0)) {
+    other.m_blocks.clear();
+}
+
+auto KVBlockTable::operator=(const KVBlockTable& other) -> KVBlockTable& {
+    if (this != &other) {
+        // retain first so that self-sharing blocks survive the release
+        for (const auto block : other.m_blocks) {
+            other.m_pool->retain(block);
+        }
+        releaseBlocks();
+
+        m_pool = other.m_pool;
+        m_blocks = other.m_blocks;
+        m_numPositions = other.m_numPositions;
+    }
+    return *this;
+}
+
+auto KVBlockTable::operator=(KVBlockTable&& other) noexcept -> KVBlockTable& {
+    if (this != &other) {
+        releaseBlocks();
+
+        m_pool = other.m_pool;
+        m_blocks = std::move(other.m_blocks);
+        m_numPositions = std::exchange(other.m_numPositions, 0);
+        other.m_blocks.clear();
+    }
+    return *this;
+}
+
+KVBlockTable::~KVBlockTable() {
+    releaseBlocks();
+}
+
+void KVBlockTable::releaseBlocks() {
+    for (const auto block : m_blocks) {
+        m_pool->release(block);
+    }
+    m_blocks.clear();
+    m_numPositions = 0;
+}
+
+auto KVBlockTable::appendSlot() -> uint8_t* {
+    const auto blockSize = m_pool->getBlockSize();
+    const auto offset = m_numPositions % blockSize;
+
+    if (offset == 0) {
+        const auto block = m_pool->allocate();
+        if (!block) {
+            return nullptr;
+        }
+        m_blocks.push_back(*block);
+    } else {
+        // the last block may still be shared with the sequence we forked from
+        const auto block = m_pool->makeWritable(m_blocks.back());
+        if (!block) {
+            return nullptr;
+        }
+        m_blocks.back() = *block;
+    }
+
+    ++m_numPositions;
+
+    return m_pool->getData(m_blocks.back())
+        + offset * m_pool->getBytesPerPosition();
+}
+
+auto KVBlockTable::getSlot(size_t position) const -> const uint8_t* {
+    const auto blockSize = m_pool->getBlockSize();
+    return m_pool->getData(m_blocks[position / blockSize])
+        + (position % blockSize) * m_pool->getBytesPerPosition();
+}
+
+}  // namespace edgellm
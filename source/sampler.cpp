@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <numeric>
@@ -145,6 +146,82 @@ auto Sampler::sample(std::vector<T>& logits) -> size_t {
     return next;
 }
 
+template<typename T>
+auto Sampler::sample(std::vector<std::vector<T>>& logits)
+    -> std::vector<size_t> {
+    std::vector<size_t> next(logits.size());
+    std::transform(logits.begin(),
+                   logits.end(),
+                   next.begin(),
+                   [this](auto& branchLogits) { return sample(branchLogits); });
+    return next;
+}
+
+template<typename T>
+auto Sampler::sampleBeams(const std::vector<std::vector<T>>& logits,
+                          const std::vector<float>& beamScores,
+                          size_t beamWidth) const
+    -> std::vector<BeamCandidate> {
+    // only the best beamWidth tokens of each beam can survive the global
+    // selection, so keep at most that many candidates per beam
+    const auto numPerBeam = std::min(beamWidth, m_vocabSize);
+
+    std::vector<BeamCandidate> candidates;
+    candidates.reserve(logits.size() * numPerBeam);
+
+    std::vector<size_t> indices(m_vocabSize);
+    for (size_t beam = 0; beam < logits.size(); ++beam) {
+        const auto& beamLogits = logits[beam];
+
+        // log-softmax normalizer, computed stably around the maximum logit
+        const auto maxVal = *std::max_element(
+            beamLogits.cbegin(),
+            beamLogits.cbegin()
+                + static_cast<std::ptrdiff_t>(m_vocabSize));
+        float sum = 0.0F;
+        for (size_t i = 0; i < m_vocabSize; ++i) {
+            sum += expf(static_cast<float>(beamLogits[i] - maxVal));
+        }
+        const auto logNorm = static_cast<float>(maxVal) + logf(sum);
+
+        std::iota(indices.begin(), indices.end(), size_t {});
+        const auto topEnd =
+            indices.begin() + static_cast<std::ptrdiff_t>(numPerBeam);
+        std::partial_sort(indices.begin(),
+                          topEnd,
+                          indices.end(),
+                          [&beamLogits](auto index1, auto index2) {
+                              return beamLogits[index1] > beamLogits[index2];
+                          });
+
+        for (auto index = indices.begin(); index != topEnd; ++index) {
+            candidates.push_back(
+                {beam,
+                 *index,
+                 beamScores[beam] + static_cast<float>(beamLogits[*index])
+                     - logNorm});
+        }
+    }
+
+    const auto numSelected = std::min(beamWidth, candidates.size());
+    std::partial_sort(candidates.begin(),
+                      candidates.begin()
+                          + static_cast<std::ptrdiff_t>(numSelected),
+                      candidates.end(),
+                      [](const auto& candidate1, const auto& candidate2) {
+                          return candidate1.score > candidate2.score;
+                      });
+    candidates.resize(numSelected);
+
+    return candidates;
+}
+
 template size_t Sampler::sample<float>(std::vector<float>& logits);
+template std::vector<size_t> Sampler::sample<float>(
+    std::vector<std::vector<float>>& logits);
+template std::vector<BeamCandidate> Sampler::sampleBeams<float>(
+    const std::vector<std::vector<float>>& logits,
+    const std::vector<float>& beamScores,
+    size_t beamWidth) const;
 
 }  // namespace edgellm
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "edgellm/sequenceGroup.hpp"
+
+#include "edgellm/kvCache.hpp"
+#include "edgellm/sampler.hpp"
+
+namespace edgellm {
+
+SequenceGroup::SequenceGroup(const KVBlockTable& promptBlocks,
+                             size_t numBranches,
+                             size_t eosId)
+    : m_branches(numBranches, SequenceBranch {promptBlocks, {}})
+    , m_eosId(eosId) {}
+
+auto SequenceGroup::forBeamSearch(const KVBlockTable& promptBlocks,
+                                  size_t eosId) -> SequenceGroup {
+    // identical beams would only ever pick identical tokens
+    SequenceGroup group(promptBlocks, 1, eosId);
+    group.m_beamSearch = true;
+    return group;
+}
+
+auto SequenceGroup::getKVSlots() -> std::vector<uint8_t*> {
+    std::vector<uint8_t*> kvSlots;
+    for (const auto& branch : m_branches) {
+        if (!branch.finished) {
+            kvSlots.push_back(branch.kvSlot);
+        }
+    }
+    return kvSlots;
+}
+
+auto SequenceGroup::hasFreeBlocks(const std::vector<size_t>& parents,
+                                  const std::vector<bool>& extended) const
+    -> bool {
+    if (m_branches.empty()) {
+        return true;
+    }
+
+    const auto& pool = m_branches.front().kvBlocks.getPool();
+    const auto blockSize = pool.getBlockSize();
+
+    const auto holds = [](const SequenceBranch& branch, size_t block) {
+        const auto& blocks = branch.kvBlocks.getBlocks();
+        return std::find(blocks.cbegin(), blocks.cend(), block)
+            != blocks.cend();
+    };
+
+    // references each written tail block will have once the children have
+    // replaced the current branches
+    std::unordered_map<size_t, size_t> tailRefs;
+    for (size_t child = 0; child < parents.size(); ++child) {
+        const auto& kvBlocks = m_branches[parents[child]].kvBlocks;
+        if (!extended[child] || kvBlocks.getNumPositions() % blockSize == 0) {
+            continue;
+        }
+
+        const auto tail = kvBlocks.getBlocks().back();
+        if (tailRefs.count(tail) != 0) {
+            continue;
+        }
+
+        auto refs = pool.getRefCount(tail);
+        for (const auto parent : parents) {
+            refs += holds(m_branches[parent], tail) ? 1 : 0;
+        }
+        for (const auto& branch : m_branches) {
+            refs -= holds(branch, tail) ? 1 : 0;
+        }
+        tailRefs.emplace(tail, refs);
+    }
+
+    // a child needs a fresh block at a block boundary and a private copy of a
+    // tail that is still shared, the last writer of a tail takes it over
+    size_t numBlocks = 0;
+    for (size_t child = 0; child < parents.size(); ++child) {
+        const auto& kvBlocks = m_branches[parents[child]].kvBlocks;
+        if (!extended[child]) {
+            continue;
+        }
+        if (kvBlocks.getNumPositions() % blockSize == 0) {
+            ++numBlocks;
+            continue;
+        }
+
+        auto& refs = tailRefs[kvBlocks.getBlocks().back()];
+        if (refs > 1) {
+            ++numBlocks;
+            --refs;
+        }
+    }
+
+    // checking up front keeps steps all-or-nothing
+    return pool.getNumFreeBlocks() >= numBlocks;
+}
+
+auto SequenceGroup::isFinished() const -> bool {
+    return getNumActive() == 0;
+}
+
+auto SequenceGroup::getNumActive() const -> size_t {
+    return static_cast<size_t>(
+        std::count_if(m_branches.cbegin(),
+                      m_branches.cend(),
+                      [](const auto& branch) { return !branch.finished; }));
+}
+
+auto SequenceGroup::appendToken(SequenceBranch& branch, size_t token) const
+    -> bool {
+    branch.tokens.push_back(token);
+    if (token == m_eosId) {
+        branch.finished = true;
+        branch.kvSlot = nullptr;
+        return true;
+    }
+
+    // copies the shared tail block the first time this branch writes to it
+    branch.kvSlot = branch.kvBlocks.appendSlot();
+    return branch.kvSlot != nullptr;
+}
+
+auto SequenceGroup::sampleStep(Sampler& sampler,
+                               std::vector<std::vector<float>>& logits)
+    -> bool {
+    if (logits.size() != getNumActive()) {
+        return false;
+    }
+
+    const auto tokens = sampler.sample(logits);
+
+    // branches ending on EOS write no keys/values, so they need no block
+    std::vector<size_t> parents(m_branches.size());
+    std::vector<bool> extended(m_branches.size());
+    auto token = tokens.cbegin();
+    for (size_t i = 0; i < m_branches.size(); ++i) {
+        parents[i] = i;
+        extended[i] = !m_branches[i].finished && *token++ != m_eosId;
+    }
+    if (!hasFreeBlocks(parents, extended)) {
+        return false;
+    }
+
+    token = tokens.cbegin();
+    for (auto& branch : m_branches) {
+        if (branch.finished) {
+            continue;
+        }
+        if (!appendToken(branch, *token++)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto SequenceGroup::beamStep(const Sampler& sampler,
+                             const std::vector<std::vector<float>>& logits,
+                             size_t beamWidth) -> bool {
+    if (!m_beamSearch || logits.size() != getNumActive()) {
+        return false;
+    }
+
+    std::vector<size_t> activeBranches;
+    std::vector<float> beamScores;
+    for (size_t i = 0; i < m_branches.size(); ++i) {
+        if (!m_branches[i].finished) {
+            activeBranches.push_back(i);
+            beamScores.push_back(m_branches[i].score);
+        }
+    }
+
+    auto candidates = sampler.sampleBeams(logits, beamScores, beamWidth);
+    for (auto& candidate : candidates) {
+        candidate.beam = activeBranches[candidate.beam];
+    }
+
+    // finished beams keep competing for a place with their final score
+    for (size_t i = 0; i < m_branches.size(); ++i) {
+        if (m_branches[i].finished) {
+            candidates.push_back({i, m_eosId, m_branches[i].score});
+        }
+    }
+
+    const auto numSelected = std::min(beamWidth, candidates.size());
+    std::partial_sort(candidates.begin(),
+                      candidates.begin()
+                          + static_cast<std::ptrdiff_t>(numSelected),
+                      candidates.end(),
+                      [](const auto& candidate1, const auto& candidate2) {
+                          return candidate1.score > candidate2.score;
+                      });
+    candidates.resize(numSelected);
+
+    std::vector<size_t> parents;
+    std::vector<bool> extended;
+    for (const auto& candidate : candidates) {
+        parents.push_back(candidate.beam);
+        extended.push_back(!m_branches[candidate.beam].finished
+                           && candidate.token != m_eosId);
+    }
+    if (!hasFreeBlocks(parents, extended)) {
+        return false;
+    }
+
+    // children share every block of their parent, including its tail
+    std::vector<SequenceBranch> nextBranches;
+    nextBranches.reserve(numSelected);
+    for (const auto& candidate : candidates) {
+        nextBranches.push_back(m_branches[candidate.beam]);
+        nextBranches.back().score = candidate.score;
+    }
+
+    // drop the parents before writing, so that the last child of each parent
+    // takes over its tail block instead of copying it
+    m_branches = std::move(nextBranches);
+
+    for (size_t i = 0; i < m_branches.size(); ++i) {
+        if (m_branches[i].finished) {
+            continue;
+        }
+        if (!appendToken(m_branches[i], candidates[i].token)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace edgellm
@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "edgellm/stopSequenceMatcher.hpp"
+
+namespace edgellm {
+
+StopSequenceMatcher::StopSequenceMatcher(
+    const std::vector<std::string>& stopSequences)
+    : m_transitions(1)
+    , m_matchLengths(1) {
+    // build the trie, 0 marks a missing edge since nothing points at the root
+    for (const auto& stopSequence : stopSequences) {
+        if (stopSequence.empty()) {
+            continue;
+        }
+
+        uint32_t node = 0;
+        for (const auto byte : stopSequence) {
+            const auto edge = static_cast<unsigned char>(byte);
+            if (m_transitions[node][edge] == 0) {
+                m_transitions[node][edge] =
+                    static_cast<uint32_t>(m_transitions.size());
+                m_transitions.emplace_back();
+                m_matchLengths.push_back(0);
+            }
+            node = m_transitions[node][edge];
+        }
+        m_matchLengths[node] = stopSequence.size();
+    }
+
+    // breadth first, so that the failure node of every node is complete by the
+    // time the node itself is visited
+    std::vector<uint32_t> failure(m_transitions.size());
+    std::queue<uint32_t> nodes;
+    nodes.push(0);
+
+    while (!nodes.empty()) {
+        const auto node = nodes.front();
+        nodes.pop();
+
+        for (size_t edge = 0; edge < MNumByteValues; ++edge) {
+            const auto child = m_transitions[node][edge];
+            const auto fallback =
+                node == 0 ? 0 : m_transitions[failure[node]][edge];
+
+            if (child == 0) {
+                // missing edges follow the longest suffix that has the edge
+                m_transitions[node][edge] = fallback;
+                continue;
+            }
+
+            failure[child] = fallback;
+            // a stop sequence may also end as a suffix of this one's prefix
+            if (m_matchLengths[child] == 0) {
+                m_matchLengths[child] = m_matchLengths[fallback];
+            }
+            nodes.push(child);
+        }
+    }
+}
+
+auto StopSequenceMatcher::feed(const std::string& piece)
+    -> std::optional<size_t> {
+    for (size_t i = 0; i < piece.size(); ++i) {
+        if (consume(piece[i])) {
+            return i + 1;
+        }
+    }
+
+    return std::nullopt;
+}
+
+}  // namespace edgellm
@@ -86,14 +86,27 @@ auto Tokenizer::decode(size_t prevToken, /* NOLINT */
     if (prevToken == m_bosTok && (*piece)[0] == ' ') {
         piece++;
     }
+
+    return pieceToBytes(*piece);
+}
+
+auto Tokenizer::getPiece(size_t token) const -> std::string {
+    if (!Tokenizer::decodeVerify(token)) {
+        return {};
+    }
+
+    return pieceToBytes(m_vocab[token]);
+}
+
+auto Tokenizer::pieceToBytes(const std::string& piece) -> std::string {
     // careful, some tokens designate raw bytes, and look like e.g. '<0x01>'
     // parse this and convert and return the actual byte
     unsigned char byteVal {};
     std::string result;
-    if (sscanf /* NOLINT */ (piece->data(), "<0x%02hhX>", &byteVal) == 1) {
+    if (sscanf /* NOLINT */ (piece.data(), "<0x%02hhX>", &byteVal) == 1) {
         result.push_back(static_cast<char>(byteVal));
     } else {
-        result = *piece;
+        result = piece;
     }
 
     return result;
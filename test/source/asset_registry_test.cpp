@@ -0,0 +1,118 @@
+#include <filesystem>
+#include <memory>
+
+#include "edgellm/assetRegistry.hpp"
+#include "edgellm/constrainedDecoder.hpp"
+#include "edgellm/edgellm.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Asset registry shares tokenizer", "[assets][tokenizer]") {
+    edgellm::AssetRegistry registry;
+
+    const auto tokenizer = registry.getTokenizer(
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin");
+    REQUIRE(tokenizer != nullptr);
+
+    const auto sameTokenizer = registry.getTokenizer(
+        "./models/llama_v2_7b_chat_quantized/../llama_v2_7b_chat_quantized/"
+        "tokenizer.bin");
+    REQUIRE(sameTokenizer == tokenizer);
+
+    REQUIRE(registry.getTokenizer("models/missing_tokenizer.bin") == nullptr);
+}
+
+TEST_CASE("Asset registry shares rope embedding", "[assets][rope]") {
+    constexpr size_t HeadDim = 128;
+    constexpr size_t MaxLength = 64;
+
+    edgellm::AssetRegistry registry;
+
+    const auto ropeEmbedding = registry.getRopeEmbedding(HeadDim, MaxLength);
+    REQUIRE(ropeEmbedding == registry.getRopeEmbedding(HeadDim, MaxLength));
+
+    std::weak_ptr<const RopeEmbedding> released;
+    {
+        const auto longerEmbedding =
+            registry.getRopeEmbedding(HeadDim, MaxLength * 2);
+        REQUIRE(longerEmbedding != ropeEmbedding);
+        released = longerEmbedding;
+    }
+    REQUIRE(released.expired());
+}
+
+TEST_CASE("Asset registry shares split models", "[assets][models]") {
+    const std::filesystem::path modelPath =
+        "models/llama_v2_7b_chat_quantized/"
+        "llama_v2_7b_chat_quantized_TokenGenerator_1_Quantized.bin";
+
+    edgellm::AssetRegistry registry;
+
+    REQUIRE(registry.getModel("models/missing_model.bin") == nullptr);
+
+    if (!std::filesystem::exists(modelPath)) {
+        SKIP("split models are not available");
+    }
+
+    const auto model = registry.getModel(modelPath);
+    REQUIRE(model != nullptr);
+    REQUIRE(registry.getModel(modelPath) == model);
+
+    // the lease is the only way to reach the model and is released with it
+    {
+        const auto lease = model->acquire();
+    }
+    const auto lease = model->acquire();
+    REQUIRE(lease->getCreationStatus() == edge::STATUS::SUCCESS);
+}
+
+TEST_CASE("EdgeLLM instances share assets", "[assets][edgellm]") {
+    const std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    const auto registry = std::make_shared<edgellm::AssetRegistry>();
+
+    edgellm::EdgeLLM first({}, {}, tokenizerPath, registry);
+    edgellm::EdgeLLM second({}, {}, tokenizerPath, registry);
+    REQUIRE(first.getCreationStatus());
+    REQUIRE(second.getCreationStatus());
+
+    // both instances hold the registry's single tokenizer
+    const auto tokenizer = registry->getTokenizer(tokenizerPath);
+    REQUIRE(tokenizer.use_count() == 3);
+
+    // and their JSON decoders read the same token masks
+    auto firstDecoder = first.createJsonDecoder();
+    auto secondDecoder = second.createJsonDecoder();
+    REQUIRE(firstDecoder.has_value());
+    REQUIRE(secondDecoder.has_value());
+
+    const auto maskCache = registry->getTokenMaskCache(tokenizerPath);
+    REQUIRE(maskCache.use_count() == 5);
+
+    firstDecoder->getAllowedTokens();
+    const auto numStates = maskCache->getNumStates();
+    secondDecoder->getAllowedTokens();
+    REQUIRE(maskCache->getNumStates() == numStates);
+}
+
+TEST_CASE("Asset registry shares token masks", "[assets][constrained]") {
+    const std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    edgellm::AssetRegistry registry;
+
+    const auto maskCache = registry.getTokenMaskCache(tokenizerPath);
+    REQUIRE(maskCache != nullptr);
+    REQUIRE(registry.getTokenMaskCache(tokenizerPath) == maskCache);
+
+    // a second generation reuses the masks computed by the first
+    edgellm::ConstrainedDecoder first(maskCache);
+    first.getAllowedTokens();
+    const auto numStates = maskCache->getNumStates();
+
+    edgellm::ConstrainedDecoder second(
+        registry.getTokenMaskCache(tokenizerPath));
+    REQUIRE(&second.getAllowedTokens() == &first.getAllowedTokens());
+    REQUIRE(maskCache->getNumStates() == numStates);
+}
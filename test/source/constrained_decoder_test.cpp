@@ -0,0 +1,200 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "edgellm/constrainedDecoder.hpp"
+#include "edgellm/jsonGrammar.hpp"
+#include "edgellm/sampler.hpp"
+#include "edgellm/tokenizer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+static auto isJson(const std::string& text) -> bool {
+    edgellm::JsonGrammar grammar;
+    for (const auto byte : text) {
+        if (!grammar.consume(byte)) {
+            return false;
+        }
+    }
+    return grammar.isComplete();
+}
+
+TEST_CASE("JSON grammar", "[constrained][json]") {
+    REQUIRE(isJson(R"({"a": [1, -2.5e+3, true, null], "b": {"c": "é"}})"));
+    REQUIRE(isJson("[]"));
+    REQUIRE(isJson(" 0 "));
+    REQUIRE(isJson(R"("text with \"escapes\"")"));
+
+    REQUIRE_FALSE(isJson(R"({"a": 1,})"));
+    REQUIRE_FALSE(isJson(R"({"a" 1})"));
+    REQUIRE_FALSE(isJson("[1, 2"));
+    REQUIRE_FALSE(isJson("01"));
+    REQUIRE_FALSE(isJson("tru"));
+    REQUIRE_FALSE(isJson("{} {}"));
+}
+
+TEST_CASE("JSON strings are UTF-8", "[constrained][json][utf8]") {
+    REQUIRE(isJson("\"\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\""));
+
+    REQUIRE_FALSE(isJson("\"\xFF\""));
+    REQUIRE_FALSE(isJson("\"\x80\""));
+    REQUIRE_FALSE(isJson("\"\xC3\""));  // truncated sequence
+    REQUIRE_FALSE(isJson("\"\xC0\x80\""));  // overlong
+    REQUIRE_FALSE(isJson("\"\xE0\x80\x80\""));  // overlong
+    REQUIRE_FALSE(isJson("\"\xED\xA0\x80\""));  // surrogate
+    REQUIRE_FALSE(isJson("\"\xF4\x90\x80\x80\""));  // beyond U+10FFFF
+}
+
+TEST_CASE("Constrained decoding yields JSON", "[constrained][decode]") {
+    std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    edgellm::Tokenizer tokenizer;
+    REQUIRE(tokenizer.load(tokenizerPath));
+
+    const auto vocabSize = tokenizer.getVocabSize();
+    const auto eosId = tokenizer.getEosTok();
+
+    // steer towards closing the value: prefer ending the output, then pieces
+    // made only of closing quotes and brackets
+    std::vector<float> bias(vocabSize);
+    for (size_t token = 0; token < vocabSize; ++token) {
+        const auto piece = tokenizer.getPiece(token);
+        if (!piece.empty()
+            && piece.find_first_not_of("\"]}") == std::string::npos)
+        {
+            bias[token] = 8.0F;
+        }
+    }
+    bias[eosId] = 16.0F;
+
+    auto maskCache = std::make_shared<edgellm::TokenMaskCache>(tokenizer);
+    edgellm::ConstrainedDecoder decoder(maskCache);
+    edgellm::Sampler sampler(vocabSize, 1.0F, 0.0F);
+
+    std::normal_distribution<float> dist;
+
+    constexpr size_t NumSeeds = 5;
+    constexpr size_t MaxTokens = 64;
+
+    for (size_t seed = 0; seed < NumSeeds; ++seed) {
+        std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
+        decoder.reset();
+
+        std::string output;
+        bool finished = false;
+        for (size_t step = 0; step < MaxTokens && !finished; ++step) {
+            std::vector<float> logits(vocabSize);
+            for (size_t token = 0; token < vocabSize; ++token) {
+                logits[token] = dist(gen) + bias[token];
+            }
+
+            decoder.applyMask(logits);
+            const auto token = sampler.sample(logits);
+            REQUIRE(decoder.accept(token));
+
+            finished = token == eosId;
+            if (!finished) {
+                output += tokenizer.getPiece(token);
+            }
+        }
+
+        REQUIRE(finished);
+        REQUIRE(isJson(output));
+    }
+
+    // string contents and digits do not create new grammar states, so all
+    // generations together only visit a handful of them
+    constexpr size_t MaxStates = 8;
+    REQUIRE(maskCache->getNumStates() <= MaxStates);
+}
+
+TEST_CASE("Masked tokens are never sampled", "[constrained][mask]") {
+    std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    edgellm::Tokenizer tokenizer;
+    REQUIRE(tokenizer.load(tokenizerPath));
+
+    edgellm::ConstrainedDecoder decoder(
+        std::make_shared<edgellm::TokenMaskCache>(tokenizer));
+
+    std::vector<float> logits(tokenizer.getVocabSize(), 0.0F);
+    decoder.applyMask(logits);
+
+    constexpr auto BitsPerWord = edgellm::TokenMaskCache::MBitsPerWord;
+
+    const auto& allowed = decoder.getAllowedTokens();
+    for (size_t token = 0; token < logits.size(); ++token) {
+        const auto isAllowed =
+            ((allowed[token / BitsPerWord] >> (token % BitsPerWord)) & 1U)
+            != 0;
+        REQUIRE(isAllowed == std::isfinite(logits[token]));
+        if (isAllowed) {
+            const auto piece = tokenizer.getPiece(token);
+            edgellm::JsonGrammar grammar;
+            for (const auto byte : piece) {
+                REQUIRE(grammar.consume(byte));
+            }
+        }
+    }
+
+    // nothing has been generated yet, so the output may not end
+    REQUIRE_FALSE(std::isfinite(logits[tokenizer.getEosTok()]));
+
+    // shorter logits are masked as far as they go, and no further
+    std::vector<float> shortLogits(BitsPerWord + 1, 0.0F);
+    decoder.applyMask(shortLogits);
+    REQUIRE(shortLogits.size() == BitsPerWord + 1);
+    for (size_t token = 0; token < shortLogits.size(); ++token) {
+        REQUIRE(std::isfinite(shortLogits[token])
+                == std::isfinite(logits[token]));
+    }
+}
+
+TEST_CASE("Lone UTF-8 bytes are masked in strings", "[constrained][utf8]") {
+    std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    edgellm::Tokenizer tokenizer;
+    REQUIRE(tokenizer.load(tokenizerPath));
+
+    auto maskCache = std::make_shared<edgellm::TokenMaskCache>(tokenizer);
+    edgellm::ConstrainedDecoder decoder(maskCache);
+
+    const auto findToken = [&maskCache](const std::string& piece) {
+        for (size_t token = 0; token < maskCache->getVocabSize(); ++token) {
+            if (maskCache->getPiece(token) == piece) {
+                return token;
+            }
+        }
+        return maskCache->getVocabSize();
+    };
+
+    const auto quoteToken = findToken("\"");
+    REQUIRE(quoteToken < maskCache->getVocabSize());
+    REQUIRE(decoder.accept(quoteToken));
+
+    const auto& allowed = decoder.getAllowedTokens();
+    const auto isAllowed = [&allowed](size_t token) {
+        constexpr auto BitsPerWord = edgellm::TokenMaskCache::MBitsPerWord;
+        return ((allowed[token / BitsPerWord] >> (token % BitsPerWord)) & 1U)
+            != 0;
+    };
+
+    for (const auto* piece : {"\x80", "\xBF", "\xC0", "\xF5", "\xFF"}) {
+        const auto token = findToken(piece);
+        REQUIRE(token < maskCache->getVocabSize());
+        REQUIRE_FALSE(isAllowed(token));
+        REQUIRE_FALSE(decoder.accept(token));
+    }
+
+    // a lead byte is fine on its own, it only has to be completed
+    const auto leadToken = findToken("\xC3");
+    REQUIRE(leadToken < maskCache->getVocabSize());
+    REQUIRE(isAllowed(leadToken));
+    REQUIRE(decoder.accept(leadToken));
+    REQUIRE_FALSE(decoder.accept(quoteToken));
+}
@@ -0,0 +1,213 @@
+#include <cstdint>
+#include <vector>
+
+#include "edgellm/kvCache.hpp"
+#include "edgellm/sampler.hpp"
+#include "edgellm/sequenceGroup.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("KV blocks are copied on write", "[kvcache][cow]") {
+    constexpr size_t NumBlocks = 8;
+    constexpr size_t BlockSize = 4;
+    constexpr size_t BytesPerPosition = 2;
+
+    edgellm::KVBlockPool pool(NumBlocks, BlockSize, BytesPerPosition);
+
+    edgellm::KVBlockTable prompt(pool);
+    for (size_t i = 0; i < BlockSize + 2; ++i) {
+        auto* slot = prompt.appendSlot();
+        REQUIRE(slot != nullptr);
+        slot[0] = static_cast<uint8_t>(i);
+    }
+    REQUIRE(pool.getNumFreeBlocks() == NumBlocks - 2);
+
+    edgellm::KVBlockTable branch = prompt;
+    REQUIRE(pool.getNumFreeBlocks() == NumBlocks - 2);
+    REQUIRE(pool.getRefCount(prompt.getBlocks().back()) == 2);
+
+    // writing into the shared tail block duplicates only that block
+    branch.appendSlot()[0] = 42;
+    REQUIRE(pool.getNumFreeBlocks() == NumBlocks - 3);
+    REQUIRE(branch.getBlocks().front() == prompt.getBlocks().front());
+    REQUIRE(branch.getBlocks().back() != prompt.getBlocks().back());
+    REQUIRE(branch.getSlot(BlockSize + 1)[0] == BlockSize + 1);
+    REQUIRE(branch.getSlot(BlockSize + 2)[0] == 42);
+
+    // the original still owns its tail block exclusively, so no copy
+    prompt.appendSlot();
+    REQUIRE(pool.getNumFreeBlocks() == NumBlocks - 3);
+}
+
+TEST_CASE("Parallel sampling shares the prompt", "[sequence][sampling]") {
+    constexpr size_t VocabSize = 4;
+    constexpr size_t EosId = 3;
+    constexpr size_t NumBranches = 3;
+    constexpr size_t BlockSize = 4;
+
+    edgellm::KVBlockPool pool(16, BlockSize, 1);
+    edgellm::KVBlockTable prompt(pool);
+    for (size_t i = 0; i < BlockSize * 2; ++i) {
+        prompt.appendSlot();
+    }
+
+    edgellm::Sampler sampler(VocabSize, 0.0F, 0.9F);
+    edgellm::SequenceGroup group(prompt, NumBranches, EosId);
+
+    std::vector<std::vector<float>> logits(NumBranches,
+                                           {0.0F, 1.0F, 0.0F, 0.0F});
+    REQUIRE(group.sampleStep(sampler, logits));
+
+    // prompt blocks are shared, each branch owns one new block
+    REQUIRE(pool.getNumFreeBlocks() == 16 - 2 - NumBranches);
+    for (const auto& branch : group.getBranches()) {
+        REQUIRE(branch.tokens == std::vector<size_t> {1});
+        REQUIRE(branch.kvBlocks.getBlocks()[0] == prompt.getBlocks()[0]);
+    }
+
+    logits = {{0.0F, 0.0F, 0.0F, 1.0F},
+              {0.0F, 0.0F, 1.0F, 0.0F},
+              {0.0F, 0.0F, 0.0F, 1.0F}};
+    REQUIRE(group.sampleStep(sampler, logits));
+    REQUIRE(group.getNumActive() == 1);
+
+    logits = {{0.0F, 0.0F, 0.0F, 1.0F}};
+    REQUIRE(group.sampleStep(sampler, logits));
+    REQUIRE(group.isFinished());
+    REQUIRE(group.getBranches()[1].tokens
+            == std::vector<size_t> {1, 2, EosId});
+}
+
+TEST_CASE("Beam search keeps the best beams", "[sequence][beam]") {
+    constexpr size_t VocabSize = 4;
+    constexpr size_t EosId = 3;
+    constexpr size_t BeamWidth = 2;
+    constexpr size_t BlockSize = 4;
+
+    edgellm::KVBlockPool pool(16, BlockSize, 1);
+    edgellm::KVBlockTable prompt(pool);
+    for (size_t i = 0; i < BlockSize; ++i) {
+        prompt.appendSlot();
+    }
+
+    edgellm::Sampler sampler(VocabSize, 0.0F, 0.9F);
+    auto group = edgellm::SequenceGroup::forBeamSearch(prompt, EosId);
+
+    std::vector<std::vector<float>> logits {{0.0F, 1.1F, 1.0F, -4.0F}};
+    REQUIRE(group.beamStep(sampler, logits, BeamWidth));
+    REQUIRE(group.getBranches().size() == BeamWidth);
+    REQUIRE(group.getBranches()[0].tokens == std::vector<size_t> {1});
+    REQUIRE(group.getBranches()[1].tokens == std::vector<size_t> {2});
+
+    // both beams share the prompt block and own one new block each
+    REQUIRE(pool.getNumFreeBlocks() == 16 - 3);
+
+    // the second beam's continuation outscores anything after the first
+    logits = {{0.0F, 0.0F, 0.0F, 0.0F}, {-8.0F, -8.0F, 8.0F, 8.0F}};
+    REQUIRE(group.beamStep(sampler, logits, BeamWidth));
+
+    const auto& branches = group.getBranches();
+    REQUIRE(branches[0].tokens.front() == 2);
+    REQUIRE(branches[1].tokens.front() == 2);
+    REQUIRE(branches[0].score >= branches[1].score);
+
+    // the dropped beam's block was recycled for the copied tail
+    REQUIRE(pool.getNumFreeBlocks() == 16 - 3);
+}
+
+TEST_CASE("KV written through slots survives forks", "[sequence][kvcache]") {
+    constexpr size_t VocabSize = 4;
+    constexpr size_t EosId = 3;
+    constexpr size_t BeamWidth = 2;
+    constexpr size_t BlockSize = 4;
+
+    edgellm::KVBlockPool pool(16, BlockSize, 1);
+    edgellm::KVBlockTable prompt(pool);
+    for (size_t i = 0; i < BlockSize; ++i) {
+        prompt.appendSlot()[0] = static_cast<uint8_t>(i);
+    }
+
+    edgellm::Sampler sampler(VocabSize, 0.0F, 0.9F);
+    auto group = edgellm::SequenceGroup::forBeamSearch(prompt, EosId);
+
+    std::vector<std::vector<float>> logits {{0.0F, 1.1F, 1.0F, -4.0F}};
+    REQUIRE(group.beamStep(sampler, logits, BeamWidth));
+
+    auto kvSlots = group.getKVSlots();
+    REQUIRE(kvSlots.size() == BeamWidth);
+    kvSlots[0][0] = 10;
+    kvSlots[1][0] = 20;
+
+    // both children fork beam 1 and copy its tail block with the written KV
+    logits = {{0.0F, 0.0F, 0.0F, 0.0F}, {-8.0F, 8.0F, 8.0F, -8.0F}};
+    REQUIRE(group.beamStep(sampler, logits, BeamWidth));
+
+    kvSlots = group.getKVSlots();
+    for (size_t i = 0; i < kvSlots.size(); ++i) {
+        kvSlots[i][0] = static_cast<uint8_t>(30 + i);
+    }
+
+    for (const auto& branch : group.getBranches()) {
+        const auto& kvBlocks = branch.kvBlocks;
+        REQUIRE(kvBlocks.getSlot(BlockSize - 1)[0] == BlockSize - 1);
+        REQUIRE(kvBlocks.getSlot(BlockSize)[0] == 20);
+    }
+    REQUIRE(group.getBranches()[0].kvBlocks.getSlot(BlockSize + 1)[0] == 30);
+    REQUIRE(group.getBranches()[1].kvBlocks.getSlot(BlockSize + 1)[0] == 31);
+}
+
+TEST_CASE("Failed steps leave the group unchanged", "[sequence][pool]") {
+    constexpr size_t VocabSize = 4;
+    constexpr size_t EosId = 3;
+    constexpr size_t BlockSize = 2;
+
+    edgellm::KVBlockPool pool(3, BlockSize, 1);
+    edgellm::KVBlockTable prompt(pool);
+    prompt.appendSlot();
+
+    edgellm::Sampler sampler(VocabSize, 0.0F, 0.9F);
+
+    // beam search needs a group that starts from a single beam
+    edgellm::SequenceGroup sampling(prompt, 2, EosId);
+    std::vector<std::vector<float>> logits(2, {0.0F, 1.0F, 0.0F, 0.0F});
+    REQUIRE_FALSE(sampling.beamStep(sampler, logits, 2));
+
+    // both branches copy the shared tail, the third takes one block too many
+    edgellm::SequenceGroup group(prompt, 3, EosId);
+    logits.assign(3, {0.0F, 1.0F, 0.0F, 0.0F});
+    REQUIRE_FALSE(group.sampleStep(sampler, logits));
+    REQUIRE(pool.getNumFreeBlocks() == 2);
+    for (const auto& branch : group.getBranches()) {
+        REQUIRE(branch.tokens.empty());
+        REQUIRE(branch.kvBlocks.getNumPositions() == 1);
+    }
+}
+
+TEST_CASE("Exhausted pools are written in place", "[sequence][pool]") {
+    constexpr size_t VocabSize = 4;
+    constexpr size_t EosId = 3;
+    constexpr size_t BlockSize = 4;
+
+    edgellm::KVBlockPool pool(2, BlockSize, 1);
+    edgellm::KVBlockTable prompt(pool);
+    prompt.appendSlot();
+
+    edgellm::Sampler sampler(VocabSize, 0.0F, 0.9F);
+    edgellm::SequenceGroup group(prompt, 1, EosId);
+
+    // the first token copies the tail shared with the prompt
+    std::vector<std::vector<float>> logits(1, {0.0F, 1.0F, 0.0F, 0.0F});
+    REQUIRE(group.sampleStep(sampler, logits));
+    REQUIRE(pool.getNumFreeBlocks() == 0);
+
+    // the copy is private now and still has room
+    logits.assign(1, {0.0F, 1.0F, 0.0F, 0.0F});
+    REQUIRE(group.sampleStep(sampler, logits));
+    REQUIRE(group.getBranches().front().tokens.size() == 2);
+    REQUIRE(group.getBranches().front().kvBlocks.getNumPositions() == 3);
+
+    // ending the branch needs no block at all
+    logits.assign(1, {0.0F, 0.0F, 0.0F, 1.0F});
+    REQUIRE(group.sampleStep(sampler, logits));
+    REQUIRE(group.isFinished());
+}
@@ -0,0 +1,63 @@
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "edgellm/stopSequenceMatcher.hpp"
+#include "edgellm/tokenizer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Stop sequences spanning pieces", "[stop][match]") {
+    edgellm::StopSequenceMatcher matcher({"</tool>", "\n\n", "abab"});
+
+    REQUIRE_FALSE(matcher.feed("result: 42 </"));
+    REQUIRE_FALSE(matcher.feed("to"));
+    REQUIRE(matcher.feed("ol> trailing") == std::optional<size_t> {3});
+    REQUIRE(matcher.getMatchLength() == 7);
+
+    // overlapping partial matches fall back to the longest matching suffix
+    matcher.reset();
+    REQUIRE_FALSE(matcher.feed("aaba"));
+    REQUIRE(matcher.feed("bab") == std::optional<size_t> {1});
+    REQUIRE(matcher.getMatchLength() == 4);
+
+    matcher.reset();
+    REQUIRE_FALSE(matcher.feed("one\n"));
+    REQUIRE(matcher.feed("\ntwo") == std::optional<size_t> {1});
+}
+
+TEST_CASE("Stop sequences nested in others", "[stop][match]") {
+    edgellm::StopSequenceMatcher matcher({"xyz", "y"});
+
+    REQUIRE(matcher.feed("xy") == std::optional<size_t> {2});
+    REQUIRE(matcher.getMatchLength() == 1);
+
+    edgellm::StopSequenceMatcher noStops;
+    REQUIRE_FALSE(noStops.feed("anything at all"));
+}
+
+TEST_CASE("Stop on detokenizer output", "[stop][tokenizer]") {
+    std::filesystem::path tokenizerPath =
+        "models/llama_v2_7b_chat_quantized/tokenizer.bin";
+
+    edgellm::Tokenizer tokenizer;
+    REQUIRE(tokenizer.load(tokenizerPath));
+
+    const std::string stopSequence = "upon a";
+    const auto tokens = tokenizer.encode("once upon a time", 1, 1);
+
+    edgellm::StopSequenceMatcher matcher({stopSequence});
+
+    std::string output;
+    for (auto token = tokens.cbegin() + 1; token != tokens.cend(); ++token) {
+        const auto piece = tokenizer.decode(*(token - 1), *token);
+        const auto matchEnd = matcher.feed(piece);
+        output += piece.substr(0, matchEnd.value_or(piece.size()));
+        if (matchEnd) {
+            break;
+        }
+    }
+
+    REQUIRE(output == "once upon a");
+}